@@ -0,0 +1,220 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <unistd.h>
+#include "markov_chain.h"
+#include "markov_score.h"
+#include "markov_train.h"
+
+#define NUM_1 1
+#define NUM_2 2
+#define NUM_3 3
+#define NUM_4 4
+
+#define FILE_PATH_ERROR "Error: incorrect file path"
+#define NUM_ARGS_ERROR "Usage: invalid number of arguments"
+
+#define DELIMITERS " \n\t\r"
+
+/**
+ * Tokens of one sentence line to score.
+ */
+typedef struct Sentence {
+    char *line; // owns the token strings
+    void **tokens;
+    int num_tokens;
+} Sentence;
+
+void print_function(const void* data) {
+    printf("%s", (char*)data);
+}
+
+int comp_function(const void* data1, const void* data2) {
+    return strcmp((const char*)data1, (const char*)data2);
+}
+
+void free_function(void* data) {
+    free(data);
+}
+
+void* copy_function(const void* data) {
+    const char *str = (const char*)data;
+    char *copy = malloc(strlen(str) + 1);
+    if (copy == NULL) {
+        return NULL;
+    }
+    strcpy(copy, str);
+    return copy;
+}
+
+bool is_last_word(const void* data) {
+    const char *str = (const char*)data;
+    size_t len = strlen(str);
+    return len > 0 && str[len - 1] == '.';
+}
+
+
+/**
+ * Free sentences and the tokens they own.
+ */
+void free_sentences(Sentence *sentences, int num_sentences) {
+    for (int i = 0; i < num_sentences; i++) {
+        free(sentences[i].line);
+        free(sentences[i].tokens);
+    }
+    free(sentences);
+}
+
+
+/**
+ * Split each line of fp, whatever its length, into a sentence of tokens.
+ * @param sentences out parameter, dynamically allocated array of sentences,
+ * NULL on failure
+ * @return number of sentences, -1 on allocation failure
+ */
+int read_sentences(FILE *fp, Sentence **sentences) {
+    char *line = NULL;
+    size_t line_capacity = 0;
+    ssize_t line_length;
+    int num_sentences = 0;
+    *sentences = NULL;
+    while ((line_length = getline(&line, &line_capacity, fp)) >= 0) {
+        Sentence *new_sentences = realloc(*sentences,
+            sizeof(Sentence) * (num_sentences + NUM_1));
+        if (new_sentences == NULL) {
+            free(line);
+            free_sentences(*sentences, num_sentences);
+            *sentences = NULL;
+            return -NUM_1;
+        }
+        *sentences = new_sentences;
+        Sentence *sentence = &(*sentences)[num_sentences++];
+        // The sentence takes the line over, getline() allocates the next.
+        sentence->line = line;
+        line = NULL;
+        line_capacity = 0;
+        // A line of n characters holds at most n / 2 + 1 words.
+        sentence->tokens = malloc(sizeof(void *) *
+                                  (line_length / NUM_2 + NUM_1));
+        sentence->num_tokens = 0;
+        if (sentence->tokens == NULL) {
+            free_sentences(*sentences, num_sentences);
+            *sentences = NULL;
+            return -NUM_1;
+        }
+        for (char *word = strtok(sentence->line, DELIMITERS); word != NULL;
+             word = strtok(NULL, DELIMITERS)) {
+            sentence->tokens[sentence->num_tokens++] = word;
+        }
+    }
+    free(line);
+    return num_sentences;
+}
+
+
+/**
+ * Score every sentence on all processors and print the results.
+ * @return 0 on success, 1 on allocation failure
+ */
+int score_sentences(MarkovChain *markov_chain, Sentence *sentences,
+                    int num_sentences, double smoothing) {
+    MarkovIndex *index = build_markov_index(markov_chain);
+    void *const **tokens = malloc(sizeof(void **) * (num_sentences + NUM_1));
+    int *lengths = malloc(sizeof(int) * (num_sentences + NUM_1));
+    SequenceScore *scores = malloc(sizeof(SequenceScore) *
+                                   (num_sentences + NUM_1));
+    int res = NUM_1;
+    if (index != NULL && tokens != NULL && lengths != NULL && scores != NULL) {
+        for (int i = 0; i < num_sentences; i++) {
+            tokens[i] = sentences[i].tokens;
+            lengths[i] = sentences[i].num_tokens;
+        }
+        long num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+        score_sequences(index, tokens, lengths, num_sentences, smoothing,
+                        num_threads < NUM_1 ? NUM_1 : (int) num_threads,
+                        scores);
+        for (int i = 0; i < num_sentences; i++) {
+            printf("Sentence %d: log_probability %.4f perplexity %.4f\n",
+                   i + NUM_1, scores[i].log_probability,
+                   scores[i].perplexity);
+        }
+        res = 0;
+    }
+    free_markov_index(&index);
+    free(tokens);
+    free(lengths);
+    free(scores);
+    return res;
+}
+
+
+/**
+ * @param argc num of arguments
+ * @param argv 1) Corpus to train the chain on
+ *             2) File of sentences to score, one per line
+ *             3) Optional, add-k smoothing (default 0)
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int main(int argc, char *argv[]) {
+    if (argc != NUM_3 && argc != NUM_4) {
+        printf(NUM_ARGS_ERROR);
+        return EXIT_FAILURE;
+    }
+    double smoothing = 0;
+    if (argc == NUM_4) {
+        char *end;
+        smoothing = strtod(argv[NUM_3], &end);
+        if (end == argv[NUM_3] || *end != '\0' || !isfinite(smoothing) ||
+            smoothing < 0) {
+            printf(NUM_ARGS_ERROR);
+            return EXIT_FAILURE;
+        }
+    }
+    FILE *corpus = fopen(argv[NUM_1], "r");
+    if (corpus == NULL) {
+        printf(FILE_PATH_ERROR);
+        return EXIT_FAILURE;
+    }
+    MarkovChain *markov_chain = malloc(sizeof(MarkovChain));
+    LinkedList *database = malloc(sizeof(LinkedList));
+    if (markov_chain == NULL || database == NULL) {
+        printf(ALLOCATION_ERROR_MESSAGE);
+        free(markov_chain);
+        free(database);
+        fclose(corpus);
+        return EXIT_FAILURE;
+    }
+    *database = (LinkedList) {NULL, NULL, 0};
+    *markov_chain = (MarkovChain) {database, print_function, comp_function,
+                                   free_function, copy_function,
+                                   is_last_word};
+    int word_count = 0;
+    int res = train_from_file(corpus, DELIMITERS, INT_MAX, &word_count,
+                              markov_chain, 0, 0);
+    fclose(corpus);
+    if (res != 0) {
+        printf(ALLOCATION_ERROR_MESSAGE);
+        free_database(&markov_chain);
+        return EXIT_FAILURE;
+    }
+    FILE *fp = fopen(argv[NUM_2], "r");
+    if (fp == NULL) {
+        printf(FILE_PATH_ERROR);
+        free_database(&markov_chain);
+        return EXIT_FAILURE;
+    }
+    Sentence *sentences;
+    int num_sentences = read_sentences(fp, &sentences);
+    fclose(fp);
+    if (num_sentences < 0 ||
+        score_sentences(markov_chain, sentences, num_sentences,
+                        smoothing) != 0) {
+        printf(ALLOCATION_ERROR_MESSAGE);
+        res = EXIT_FAILURE;
+    }
+    free_sentences(sentences, num_sentences < 0 ? 0 : num_sentences);
+    free_database(&markov_chain);
+    return res == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
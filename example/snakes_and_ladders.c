@@ -1,5 +1,6 @@
 #include <string.h> // For strlen(), strcmp(), strcpy()
 #include "markov_chain.h"
+#include "markov_walks.h"
 
 #define MAX(X, Y) (((X) < (Y)) ? (Y) : (X))
 
@@ -13,9 +14,11 @@
 #define NUM_1 1
 #define NUM_2 2
 #define NUM_3 3
+#define NUM_4 4
 #define NUM_10 10
 
 #define NUM_ARGS_ERROR "Usage: invalid number of arguments"
+#define OUTPUT_FILE_ERROR "Error: could not write output file"
 
 /**
  * represents the transitions by ladders and snakes in the game
@@ -247,14 +250,55 @@ void generate_walks(MarkovChain *markov_chain, int num_of_walks) {
     }
 }
 
+/**
+ * Generate the walks as state ids and write them to a binary file, see
+ * write_walks(). State id i is cell number i + 1.
+ * @param markov_chain
+ * @param num_of_walks
+ * @param output_path file to write
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int write_walks_file(MarkovChain *markov_chain, int num_of_walks,
+                     const char *output_path) {
+    MarkovWalks *walks = create_walks();
+    if (walks == NULL) {
+        printf(ALLOCATION_ERROR_MESSAGE);
+        return EXIT_FAILURE;
+    }
+    if (generate_walks_columnar(markov_chain,
+                                markov_chain->database->first->data,
+                                MAX_GENERATION_LENGTH, num_of_walks,
+                                walks) != EXIT_SUCCESS) {
+        free_walks(&walks);
+        return EXIT_FAILURE;
+    }
+    FILE *fp = fopen(output_path, "wb");
+    if (fp == NULL || write_walks(walks, fp) != EXIT_SUCCESS) {
+        printf(OUTPUT_FILE_ERROR);
+        if (fp != NULL) {
+            fclose(fp);
+        }
+        free_walks(&walks);
+        return EXIT_FAILURE;
+    }
+    free_walks(&walks);
+    if (fclose(fp) != 0) {
+        printf(OUTPUT_FILE_ERROR);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
 /**
  * @param argc num of arguments
  * @param argv 1) Seed
  *             2) Number of sentences to generate
+ *             3) Optional, binary file to write the walks to instead of
+ *                printing them
  * @return EXIT_SUCCESS or EXIT_FAILURE
  */
 int main(int argc, char *argv[]) {
-    if (argc != NUM_3) {
+    if (argc != NUM_3 && argc != NUM_4) {
         printf(NUM_ARGS_ERROR);
         return EXIT_FAILURE;
     }
@@ -285,9 +329,14 @@ int main(int argc, char *argv[]) {
         free_database(&markov_chain);
         return EXIT_FAILURE;
     }
-    generate_walks(markov_chain, num_of_walks);
+    int res = EXIT_SUCCESS;
+    if (argc == NUM_4) {
+        res = write_walks_file(markov_chain, num_of_walks, argv[NUM_3]);
+    } else {
+        generate_walks(markov_chain, num_of_walks);
+    }
     free_database(&markov_chain);
-    return EXIT_SUCCESS;
+    return res;
 }
 
 
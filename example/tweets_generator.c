@@ -2,16 +2,21 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
 #include "markov_chain.h"
+#include "markov_walks.h"
+#include "markov_train.h"
 
 #define NUM_1 1
 #define NUM_2 2
 #define NUM_3 3
 #define NUM_4 4
 #define NUM_5 5
+#define NUM_6 6
 #define NUM_10 10
 #define NUM_20 20
-#define NUM_1000 1000
 
 
 //Don't change the macros!
@@ -19,6 +24,18 @@
 #define NUM_ARGS_ERROR "Usage: invalid number of arguments"
 
 #define DELIMITERS " \n\t\r"
+#define CORPUS_SEPARATORS ","
+#define WEIGHT_SEPARATOR ':'
+#define RANGE_SEPARATOR '-'
+#define TWEETS_BATCH_SIZE 4096
+
+/**
+ * A training corpus given on the command line as path[:weight]
+ */
+typedef struct Corpus {
+    char *path;
+    double weight;
+} Corpus;
 
 void print_function(const void* data) {
     printf("%s", (char*)data);
@@ -57,38 +74,6 @@ bool is_last_word(const void* data) {
 
 
 
-int fill_database(FILE *fp, int words_to_read, MarkovChain *markov_chain) {
-    char line[NUM_1000];
-    int word_count = 0;
-    MarkovNode *prev_node = NULL;
-    while (fgets(line, NUM_1000, fp) != NULL &&
-        word_count < words_to_read) {
-        char *word = strtok(line, DELIMITERS);
-        while (word != NULL && word_count < words_to_read) {
-            Node *current_node = add_to_database(markov_chain, word);
-            if (current_node == NULL) {
-                return NUM_1;
-            }
-            if (prev_node != NULL) {
-                if (add_node_to_frequency_list(prev_node,
-                    current_node->data) != 0) {
-                    return NUM_1;
-                }
-            }
-            if (markov_chain->is_last(word)) {
-                prev_node = NULL;
-            } else {
-                prev_node = current_node->data;
-            }
-            word_count++;
-            word = strtok(NULL, DELIMITERS);
-        }
-        prev_node = NULL;
-    }
-    return 0;
-}
-
-
 MarkovChain *initialize_markov_chain() {
     MarkovChain *markov_chain = malloc(sizeof(MarkovChain));
     if (markov_chain == NULL) {
@@ -117,17 +102,157 @@ void generate_tweets(MarkovChain *markov_chain, int num_of_tweets) {
 }
 
 
+/**
+ * Print tweets generated from the blend of corpora described by weights.
+ * @return 0 on success, 1 on allocation failure
+ */
+int generate_blended_tweets(MarkovChain *markov_chain, int num_of_tweets,
+                            const double *weights, int num_corpora) {
+    int size = markov_chain->database->size + NUM_1;
+    MarkovNode **first_nodes = malloc(sizeof(MarkovNode *) * size);
+    double *start_weights = malloc(sizeof(double) * size);
+    int num_first_nodes = -NUM_1;
+    if (first_nodes != NULL && start_weights != NULL) {
+        num_first_nodes = get_first_nodes(markov_chain, weights, num_corpora,
+                                          first_nodes, start_weights);
+    }
+    if (num_first_nodes < 0) {
+        free(first_nodes);
+        free(start_weights);
+        return NUM_1;
+    }
+    for (int i = NUM_1; i <= num_of_tweets; i++) {
+        printf("Tweet %d: ", i);
+        MarkovNode *start_node = get_first_blended_node(first_nodes,
+                                                        start_weights,
+                                                        num_first_nodes);
+        if (start_node != NULL) {
+            generate_blended_sequence(markov_chain, start_node, NUM_20,
+                                      weights, num_corpora);
+        } else {
+            printf("\n");
+        }
+    }
+    free(first_nodes);
+    free(start_weights);
+    return 0;
+}
+
+
+/**
+ * Print tweets first_tweet .. last_tweet. Tweet n depends only on seed and
+ * n, so a range prints the same tweets as any wider range containing it, and
+ * each batch of tweets is generated on all processors.
+ * @param weights weight of each corpus, NULL to use the plain frequencies
+ * @return 0 on success, 1 on allocation failure
+ */
+int generate_seekable_tweets(MarkovChain *markov_chain, unsigned int seed,
+                             int first_tweet, int last_tweet,
+                             const double *weights, int num_corpora) {
+    MarkovNode **nodes_by_id = get_nodes_by_id(markov_chain);
+    MarkovWalks *walks = create_walks();
+    if (nodes_by_id == NULL || walks == NULL) {
+        free(nodes_by_id);
+        free_walks(&walks);
+        return NUM_1;
+    }
+    long num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (num_threads < NUM_1) {
+        num_threads = NUM_1;
+    }
+    for (long long first = first_tweet; first <= last_tweet;
+         first += TWEETS_BATCH_SIZE) {
+        int batch = TWEETS_BATCH_SIZE;
+        if (last_tweet - first + NUM_1 < batch) {
+            batch = (int) (last_tweet - first + NUM_1);
+        }
+        walks->num_walks = 0;
+        if (generate_walks_seekable(markov_chain, seed, (uint64_t) first,
+                                    batch, NUM_20, weights, num_corpora,
+                                    (int) num_threads, walks) != 0) {
+            free(nodes_by_id);
+            free_walks(&walks);
+            return NUM_1;
+        }
+        for (int i = 0; i < batch; i++) {
+            printf("Tweet %lld: ", first + i);
+            print_walk(markov_chain, nodes_by_id, walks, i);
+        }
+    }
+    free(nodes_by_id);
+    free_walks(&walks);
+    return 0;
+}
+
+
+/**
+ * Split a comma separated list of path[:weight] entries. A missing weight
+ * defaults to 1.
+ * @param arg the list, modified in place
+ * @param corpora out parameter, dynamically allocated array of corpora
+ * @return number of corpora, -1 on allocation failure
+ */
+int parse_corpora(char *arg, Corpus **corpora) {
+    int num_corpora = 0;
+    *corpora = NULL;
+    for (char *entry = strtok(arg, CORPUS_SEPARATORS); entry != NULL;
+         entry = strtok(NULL, CORPUS_SEPARATORS)) {
+        Corpus *new_corpora = realloc(*corpora,
+            sizeof(Corpus) * (num_corpora + NUM_1));
+        if (new_corpora == NULL) {
+            free(*corpora);
+            *corpora = NULL;
+            return -NUM_1;
+        }
+        *corpora = new_corpora;
+        Corpus *corpus = &(*corpora)[num_corpora++];
+        corpus->path = entry;
+        corpus->weight = NUM_1;
+        char *separator = strrchr(entry, WEIGHT_SEPARATOR);
+        if (separator != NULL) {
+            char *end;
+            double weight = strtod(separator + NUM_1, &end);
+            if (end != separator + NUM_1 && *end == '\0' && weight >= 0) {
+                *separator = '\0';
+                corpus->weight = weight;
+            }
+        }
+    }
+    return num_corpora;
+}
+
+
 
 int main(int argc, char *argv[]) {
-    if (argc < NUM_4 || argc > NUM_5) {
+    if (argc < NUM_4 || argc > NUM_6) {
         printf(NUM_ARGS_ERROR);
         return EXIT_FAILURE;
     }
     unsigned int seed = (unsigned int)strtoul(argv[NUM_1], NULL, NUM_10);
-    int num_of_tweets = (int)strtol(argv[NUM_2], NULL, NUM_10);
-    char *file_path = argv[NUM_3];
+    char *range_end;
+    errno = 0;
+    long first = strtol(argv[NUM_2], &range_end, NUM_10);
+    bool out_of_range = errno == ERANGE || first > INT_MAX;
+    int num_of_tweets = (int)first;
+    // first-last selects a range of tweets of the seekable generator
+    bool seekable = *range_end == RANGE_SEPARATOR;
+    int first_tweet = num_of_tweets;
+    if (seekable) {
+        char *last_start = range_end + NUM_1;
+        char *last_end;
+        errno = 0;
+        long last = strtol(last_start, &last_end, NUM_10);
+        out_of_range = out_of_range || errno == ERANGE || last > INT_MAX;
+        if (out_of_range || first < NUM_1 ||
+            !isdigit((unsigned char) *last_start) || *last_end != '\0' ||
+            last < first) {
+            printf(NUM_ARGS_ERROR);
+            return EXIT_FAILURE;
+        }
+        num_of_tweets = (int)last;
+    }
     int words_to_read;
-    if (argc == NUM_5) {
+    if (argc >= NUM_5) {
         words_to_read = (int)strtol(argv[NUM_4], NULL, NUM_10);
     } else {
         words_to_read = -1;
@@ -135,16 +260,28 @@ int main(int argc, char *argv[]) {
     if (words_to_read <= 0) {
         words_to_read = INT_MAX;
     }
+    int max_successors = 0;
+    if (argc == NUM_6) {
+        max_successors = (int)strtol(argv[NUM_5], NULL, NUM_10);
+    }
     srand(seed);
-    FILE *fp = fopen(file_path, "r");
-    if (fp == NULL) {
+    Corpus *corpora;
+    int num_corpora = parse_corpora(argv[NUM_3], &corpora);
+    if (num_corpora < 0) {
+        printf(ALLOCATION_ERROR_MESSAGE);
+        return EXIT_FAILURE;
+    }
+    if (num_corpora == 0) {
         printf(FILE_PATH_ERROR);
         return EXIT_FAILURE;
     }
+    double *weights = malloc(sizeof(double) * num_corpora);
     MarkovChain *markov_chain = initialize_markov_chain();
-    if (markov_chain == NULL) {
+    if (weights == NULL || markov_chain == NULL) {
         printf(ALLOCATION_ERROR_MESSAGE);
-        fclose(fp);
+        free(weights);
+        free_database(&markov_chain);
+        free(corpora);
         return EXIT_FAILURE;
     }
     markov_chain->print_f = print_function;
@@ -152,15 +289,52 @@ int main(int argc, char *argv[]) {
     markov_chain->free_data = free_function;
     markov_chain->copy_f = copy_function;
     markov_chain->is_last = is_last_word;
-    if (fill_database(fp, words_to_read, markov_chain) != 0) {
+    int word_count = 0;
+    for (int i = 0; i < num_corpora; i++) {
+        weights[i] = corpora[i].weight;
+        FILE *fp = fopen(corpora[i].path, "r");
+        if (fp == NULL) {
+            printf(FILE_PATH_ERROR);
+            free(weights);
+            free_database(&markov_chain);
+            free(corpora);
+            return EXIT_FAILURE;
+        }
+        if (train_from_file(fp, DELIMITERS, words_to_read, &word_count,
+                            markov_chain, i, max_successors) != 0) {
+            printf(ALLOCATION_ERROR_MESSAGE);
+            free(weights);
+            free_database(&markov_chain);
+            free(corpora);
+            fclose(fp);
+            return EXIT_FAILURE;
+        }
+        fclose(fp);
+    }
+    if (seekable) {
+        if (generate_seekable_tweets(markov_chain, seed, first_tweet,
+                                     num_of_tweets,
+                                     num_corpora == NUM_1 ? NULL : weights,
+                                     num_corpora) != 0) {
+            printf(ALLOCATION_ERROR_MESSAGE);
+            free(weights);
+            free_database(&markov_chain);
+            free(corpora);
+            return EXIT_FAILURE;
+        }
+    } else if (num_corpora == NUM_1) {
+        generate_tweets(markov_chain, num_of_tweets);
+    } else if (generate_blended_tweets(markov_chain, num_of_tweets, weights,
+                                       num_corpora) != 0) {
         printf(ALLOCATION_ERROR_MESSAGE);
+        free(weights);
         free_database(&markov_chain);
-        fclose(fp);
+        free(corpora);
         return EXIT_FAILURE;
     }
-    fclose(fp);
-    generate_tweets(markov_chain, num_of_tweets);
+    free(weights);
     free_database(&markov_chain);
+    free(corpora);
     return EXIT_SUCCESS;
 }
 
@@ -0,0 +1,63 @@
+#include "counter_rng.h"
+
+#define PHILOX_ROUNDS 10
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define WORD_BITS 32
+#define BLOCK_WORDS 4
+
+void philox4x32(const uint32_t counter[4], const uint32_t key[2],
+                uint32_t out[4]) {
+    uint32_t c0 = counter[0], c1 = counter[1];
+    uint32_t c2 = counter[2], c3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int round = 0; round < PHILOX_ROUNDS; round++) {
+        uint64_t product0 = (uint64_t) PHILOX_M0 * c0;
+        uint64_t product1 = (uint64_t) PHILOX_M1 * c2;
+        c0 = (uint32_t) (product1 >> WORD_BITS) ^ c1 ^ k0;
+        c1 = (uint32_t) product1;
+        c2 = (uint32_t) (product0 >> WORD_BITS) ^ c3 ^ k1;
+        c3 = (uint32_t) product0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+void init_counter_rng(CounterRng *rng, uint64_t seed, uint64_t stream) {
+    rng->key[0] = (uint32_t) seed;
+    rng->key[1] = (uint32_t) (seed >> WORD_BITS);
+    rng->counter[0] = 0;
+    rng->counter[1] = 0;
+    rng->counter[2] = (uint32_t) stream;
+    rng->counter[3] = (uint32_t) (stream >> WORD_BITS);
+    rng->used = BLOCK_WORDS;
+}
+
+uint32_t counter_rng_next(CounterRng *rng) {
+    if (rng->used == BLOCK_WORDS) {
+        philox4x32(rng->counter, rng->key, rng->block);
+        rng->used = 0;
+        if (++rng->counter[0] == 0) {
+            rng->counter[1]++;
+        }
+    }
+    return rng->block[rng->used++];
+}
+
+int counter_rng_number(CounterRng *rng, int max_number) {
+    // Multiply-shift maps 32 random bits onto [0, max_number).
+    return (int) (((uint64_t) counter_rng_next(rng) * (uint32_t) max_number)
+                  >> WORD_BITS);
+}
+
+double counter_rng_fraction(CounterRng *rng) {
+    uint64_t high = counter_rng_next(rng) >> 5; // 27 bits
+    uint64_t low = counter_rng_next(rng) >> 6; // 26 bits
+    return (double) ((high << 26) | low) / (double) (1ULL << 53);
+}
@@ -0,0 +1,55 @@
+#ifndef _COUNTER_RNG_H_
+#define _COUNTER_RNG_H_
+#include <stdint.h> // For uint32_t, uint64_t
+
+/**
+ * Counter based random number generator (Philox4x32-10). The n-th number of
+ * stream s under seed k is a pure function of (k, s, n), so any stream can
+ * be replayed on its own, on any thread, without generating the others.
+ */
+typedef struct CounterRng {
+    uint32_t key[2];
+    uint32_t counter[4]; // draw number (low words), stream (high words)
+    uint32_t block[4]; // output of the last counter
+    int used; // numbers of block already returned
+} CounterRng;
+
+/**
+ * Philox4x32-10 bijection: encrypt counter with key.
+ * @param counter 128 bit counter
+ * @param key 64 bit key
+ * @param out 128 random bits
+ */
+void philox4x32(const uint32_t counter[4], const uint32_t key[2],
+                uint32_t out[4]);
+
+/**
+ * Position rng at the start of a stream.
+ * @param rng
+ * @param seed key of the generator
+ * @param stream index of the stream, e.g. the index of a generated sequence
+ */
+void init_counter_rng(CounterRng *rng, uint64_t seed, uint64_t stream);
+
+/**
+ * @param rng
+ * @return next 32 random bits of the stream
+ */
+uint32_t counter_rng_next(CounterRng *rng);
+
+/**
+ * Get random number between 0 and max_number [0, max_number).
+ * @param rng
+ * @param max_number > 0
+ * @return Random number
+ */
+int counter_rng_number(CounterRng *rng, int max_number);
+
+/**
+ * Get random fraction in [0, 1).
+ * @param rng
+ * @return Random fraction
+ */
+double counter_rng_fraction(CounterRng *rng);
+
+#endif //_COUNTER_RNG_H_
@@ -13,6 +13,63 @@ int get_random_number(int max_number)
     return rand() % max_number;
 }
 
+/**
+ * Get random fraction in [0, 1).
+ * @return Random fraction
+ */
+static double get_random_fraction(void)
+{
+    return rand() / ((double) RAND_MAX + NUM_1);
+}
+
+/**
+ * Weight of a single transition out of markov_node in the blend of corpora.
+ * @return weights[corpus] * frequency / total of the corpus out of
+ * markov_node, 0 if corpus is not in the blend
+ */
+static double blended_frequency(const MarkovNode *markov_node,
+                                const MarkovNodeFrequency *transition,
+                                const double *weights, int num_corpora)
+{
+    if (transition->corpus >= num_corpora) {
+        return 0;
+    }
+    return weights[transition->corpus] * transition->frequency /
+        markov_node->corpus_totals[transition->corpus];
+}
+
+/**
+ * Make room in corpus_totals of markov_node for the given corpus.
+ * @return 0 on success, 1 in case of allocation error
+ */
+static int reserve_corpus_total(MarkovNode *markov_node, int corpus)
+{
+    if (corpus < markov_node->num_corpora) {
+        return EXIT_SUCCESS;
+    }
+    int *corpus_totals = realloc(markov_node->corpus_totals,
+                                 sizeof(int) * (corpus + NUM_1));
+    if (corpus_totals == NULL) {
+        return EXIT_FAILURE;
+    }
+    memset(corpus_totals + markov_node->num_corpora, 0,
+           sizeof(int) * (corpus + NUM_1 - markov_node->num_corpora));
+    markov_node->corpus_totals = corpus_totals;
+    markov_node->num_corpora = corpus + NUM_1;
+    return EXIT_SUCCESS;
+}
+
+double get_blended_total(const MarkovNode *markov_node,
+                         const double *weights, int num_corpora) {
+    double total = 0;
+    for (int i = 0; i < markov_node->num_corpora && i < num_corpora; i++) {
+        if (markov_node->corpus_totals[i] > 0) {
+            total += weights[i];
+        }
+    }
+    return total;
+}
+
 Node *get_node_from_database(MarkovChain *markov_chain, void *data_ptr) {
     if (markov_chain == NULL || markov_chain->database == NULL) {
         return NULL;
@@ -45,6 +102,10 @@ Node* add_to_database(MarkovChain *markov_chain, void *data_ptr) {
     }
     new_markov_node->frequency_list = NULL;
     new_markov_node->frequency_size = 0;
+    new_markov_node->total_frequency = 0;
+    new_markov_node->corpus_totals = NULL;
+    new_markov_node->num_corpora = 0;
+    new_markov_node->id = markov_chain->database->size;
     if (add(markov_chain->database, new_markov_node) != 0) {
         return NULL;
     }
@@ -54,6 +115,16 @@ Node* add_to_database(MarkovChain *markov_chain, void *data_ptr) {
 
 int add_node_to_frequency_list(MarkovNode *first_node,
     MarkovNode *second_node) {
+    return add_node_to_corpus_frequency_list(first_node, second_node, 0);
+}
+
+
+int add_node_to_corpus_frequency_list(MarkovNode *first_node,
+    MarkovNode *second_node, int corpus) {
+    if (reserve_corpus_total(first_node, corpus) != EXIT_SUCCESS) {
+        printf(ALLOCATION_ERROR_MESSAGE);
+        return EXIT_FAILURE;
+    }
     if(!first_node->frequency_list) {
         first_node->frequency_list = malloc(sizeof(MarkovNodeFrequency));
         if(first_node->frequency_list == NULL) {
@@ -63,29 +134,74 @@ int add_node_to_frequency_list(MarkovNode *first_node,
         first_node->frequency_size = NUM_1;
         first_node->frequency_list[0].markov_node = second_node;
         first_node->frequency_list[0].frequency= NUM_1;
+        first_node->frequency_list[0].corpus = corpus;
+        first_node->total_frequency = NUM_1;
+        first_node->corpus_totals[corpus] = NUM_1;
         return EXIT_SUCCESS;
     }
     MarkovNodeFrequency *current_frequency = first_node->frequency_list;
     for(int i=0; i<first_node->frequency_size; i++) {
-        if(current_frequency[i].markov_node == second_node) {
+        if(current_frequency[i].markov_node == second_node &&
+            current_frequency[i].corpus == corpus) {
             current_frequency[i].frequency++;
+            first_node->total_frequency++;
+            first_node->corpus_totals[corpus]++;
             return EXIT_SUCCESS;
         }
     }
-    first_node->frequency_list = realloc(first_node->frequency_list,
+    MarkovNodeFrequency *new_list = realloc(first_node->frequency_list,
         sizeof(MarkovNodeFrequency) * (first_node->frequency_size + NUM_1));
-    if(first_node->frequency_list == NULL) {
+    if(new_list == NULL) {
         printf(ALLOCATION_ERROR_MESSAGE);
         return EXIT_FAILURE;
     }
+    first_node->frequency_list = new_list;
     first_node->frequency_list[first_node->frequency_size].markov_node \
     = second_node;
     first_node->frequency_list[first_node->frequency_size].frequency = 1;
+    first_node->frequency_list[first_node->frequency_size].corpus = corpus;
     first_node->frequency_size += 1;
+    first_node->total_frequency++;
+    first_node->corpus_totals[corpus]++;
     return 0;
 }
 
 
+int add_node_to_bounded_frequency_list(MarkovNode *first_node,
+    MarkovNode *second_node, int corpus, int max_successors) {
+    MarkovNodeFrequency *current_frequency = first_node->frequency_list;
+    int corpus_size = 0;
+    int min_index = -NUM_1;
+    for (int i = 0; i < first_node->frequency_size; i++) {
+        if (current_frequency[i].corpus != corpus) {
+            continue;
+        }
+        if (current_frequency[i].markov_node == second_node) {
+            current_frequency[i].frequency++;
+            first_node->total_frequency++;
+            first_node->corpus_totals[corpus]++;
+            return EXIT_SUCCESS;
+        }
+        corpus_size++;
+        if (min_index < 0 || current_frequency[i].frequency <
+            current_frequency[min_index].frequency) {
+            min_index = i;
+        }
+    }
+    if (corpus_size < max_successors) {
+        return add_node_to_corpus_frequency_list(first_node, second_node,
+                                                 corpus);
+    }
+    // Evict within the same corpus only, so counts never move between
+    // corpora and the blend weights stay meaningful.
+    current_frequency[min_index].markov_node = second_node;
+    current_frequency[min_index].frequency++;
+    first_node->total_frequency++;
+    first_node->corpus_totals[corpus]++;
+    return EXIT_SUCCESS;
+}
+
+
 void free_database(MarkovChain ** ptr_chain) {
     if (ptr_chain == NULL || *ptr_chain == NULL) {
         return;
@@ -100,6 +216,7 @@ void free_database(MarkovChain ** ptr_chain) {
                 if(markov_node->frequency_list) {
                     free(markov_node->frequency_list);
                 }
+                free(markov_node->corpus_totals);
                 markov_chain->free_data(markov_node->data);
                 free(markov_node);
             }
@@ -128,11 +245,12 @@ MarkovNode *get_first_random_node(MarkovChain *markov_chain) {
 
 
 MarkovNode* get_next_random_node(MarkovNode *cur_markov_node) {
-    int total_frequency = 0;
-    for(int i = 0; i < cur_markov_node->frequency_size; i++) {
-        total_frequency += cur_markov_node->frequency_list[i].frequency;
-    }
-    int random_number = get_random_number(total_frequency);
+    return select_next_node(cur_markov_node,
+        get_random_number(cur_markov_node->total_frequency));
+}
+
+
+MarkovNode *select_next_node(MarkovNode *cur_markov_node, int random_number) {
     for(int i = 0; i < cur_markov_node->frequency_size; i++) {
         random_number -= cur_markov_node->frequency_list[i].frequency;
         if(random_number < 0) {
@@ -162,3 +280,133 @@ void generate_random_sequence(MarkovChain *markov_chain,
 }
 
 
+int get_first_nodes(MarkovChain *markov_chain, const double *weights,
+                    int num_corpora, MarkovNode **first_nodes,
+                    double *start_weights) {
+    int num_first_nodes = 0;
+    for (Node *node = markov_chain->database->first; node != NULL;
+         node = node->next) {
+        MarkovNode *markov_node = node->data;
+        if (markov_chain->is_last(markov_node->data)) {
+            continue;
+        }
+        if (weights != NULL ?
+            get_blended_total(markov_node, weights, num_corpora) > 0 :
+            markov_node->frequency_list != NULL) {
+            first_nodes[num_first_nodes++] = markov_node;
+        }
+    }
+    if (weights == NULL) {
+        return num_first_nodes;
+    }
+    // Number of first nodes of each corpus, to spread its weight over.
+    int *corpus_sizes = calloc(num_corpora + NUM_1, sizeof(int));
+    if (corpus_sizes == NULL) {
+        printf(ALLOCATION_ERROR_MESSAGE);
+        return -NUM_1;
+    }
+    for (int i = 0; i < num_first_nodes; i++) {
+        for (int j = 0; j < first_nodes[i]->num_corpora && j < num_corpora;
+             j++) {
+            corpus_sizes[j] += first_nodes[i]->corpus_totals[j] > 0;
+        }
+    }
+    double start_weight = 0;
+    for (int i = 0; i < num_first_nodes; i++) {
+        for (int j = 0; j < first_nodes[i]->num_corpora && j < num_corpora;
+             j++) {
+            if (first_nodes[i]->corpus_totals[j] > 0) {
+                start_weight += weights[j] / corpus_sizes[j];
+            }
+        }
+        start_weights[i] = start_weight;
+    }
+    free(corpus_sizes);
+    return num_first_nodes;
+}
+
+
+MarkovNode *get_first_blended_node(MarkovNode **first_nodes,
+                                   const double *start_weights,
+                                   int num_first_nodes) {
+    return select_first_blended_node(first_nodes, start_weights,
+                                     num_first_nodes, get_random_fraction());
+}
+
+
+MarkovNode *select_first_blended_node(MarkovNode **first_nodes,
+                                      const double *start_weights,
+                                      int num_first_nodes, double fraction) {
+    if (num_first_nodes == 0) {
+        return NULL;
+    }
+    // First node whose summed start weight is above the drawn one.
+    double random_number = fraction * start_weights[num_first_nodes - NUM_1];
+    int low = 0, high = num_first_nodes - NUM_1;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (start_weights[middle] > random_number) {
+            high = middle;
+        } else {
+            low = middle + NUM_1;
+        }
+    }
+    return first_nodes[low];
+}
+
+
+MarkovNode *get_next_blended_node(MarkovNode *cur_markov_node,
+                                  const double *weights, int num_corpora) {
+    return select_next_blended_node(cur_markov_node, weights, num_corpora,
+                                    get_random_fraction());
+}
+
+
+MarkovNode *select_next_blended_node(MarkovNode *cur_markov_node,
+                                     const double *weights, int num_corpora,
+                                     double fraction) {
+    double total = get_blended_total(cur_markov_node, weights, num_corpora);
+    if (total <= 0) {
+        return NULL;
+    }
+    double random_number = fraction * total;
+    MarkovNode *last_candidate = NULL;
+    for (int i = 0; i < cur_markov_node->frequency_size; i++) {
+        double frequency = blended_frequency(cur_markov_node,
+            &cur_markov_node->frequency_list[i], weights, num_corpora);
+        if (frequency <= 0) {
+            continue;
+        }
+        last_candidate = cur_markov_node->frequency_list[i].markov_node;
+        random_number -= frequency;
+        if (random_number < 0) {
+            return last_candidate;
+        }
+    }
+    // Only reachable through floating point rounding of the total.
+    return last_candidate;
+}
+
+
+void generate_blended_sequence(MarkovChain *markov_chain,
+                               MarkovNode *first_node, int max_length,
+                               const double *weights, int num_corpora) {
+    MarkovNode *current_node = first_node;
+    int word_count = 0;
+    while (current_node != NULL && word_count < max_length) {
+        markov_chain->print_f(current_node->data);
+        word_count++;
+        MarkovNode *next_node = get_next_blended_node(current_node, weights,
+                                                      num_corpora);
+        if (next_node == NULL) {
+            break;
+        }
+        if (word_count < max_length) {
+            printf(" ");
+        }
+        current_node = next_node;
+    }
+    printf("\n");
+}
+
+
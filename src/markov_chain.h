@@ -28,12 +28,17 @@ typedef struct MarkovNode {
     void *data;
     struct MarkovNodeFrequency *frequency_list;
     int frequency_size;
+    int total_frequency; // sum of the frequencies in frequency_list
+    int id; // position of the node in the database, starting at 0
+    int *corpus_totals; // total_frequency of each corpus, by corpus index
+    int num_corpora; // number of entries in corpus_totals
     // any other fields you need
 } MarkovNode;
 
 typedef struct MarkovNodeFrequency {
     struct MarkovNode *markov_node;
     int frequency;
+    int corpus; // index of the corpus this transition was counted in
     // any other fields you need
 } MarkovNodeFrequency;
 
@@ -83,6 +88,44 @@ Node *add_to_database(MarkovChain *markov_chain, void *data_ptr);
 int add_node_to_frequency_list(MarkovNode *first_node,
                                MarkovNode *second_node);
 
+/**
+ * Add the second markov_node to the frequency list of the first markov_node,
+ * counted under the given corpus. Several corpora can be trained into one
+ * chain this way: they share the chain's states, and each keeps its own
+ * transition counts. add_node_to_frequency_list() counts under corpus 0.
+ * @param first_node
+ * @param second_node
+ * @param corpus index of the corpus the transition was read from (>= 0)
+ * @return success/failure: 0 if the process was successful, 1 if in
+ * case of allocation error.
+ */
+int add_node_to_corpus_frequency_list(MarkovNode *first_node,
+                                      MarkovNode *second_node, int corpus);
+
+/**
+ * Approximate version of add_node_to_corpus_frequency_list() that keeps at
+ * most max_successors transitions per node and corpus, using the
+ * Space-Saving heavy-hitters algorithm: when the corpus' transitions are
+ * full, a new transition replaces the one of the same corpus with the lowest
+ * count and inherits that count plus one.
+ * With k = max_successors and N = number of transitions of this corpus
+ * counted out of first_node so far:
+ * - the corpus' frequencies in the list still sum to exactly N,
+ * - a kept frequency overestimates the true count by at most N / k,
+ * - every transition whose true count is above N / k is kept.
+ * Memory per node is therefore bounded by k transitions per corpus, whatever
+ * the size of the corpora; memory for the states themselves stays exact.
+ * @param first_node
+ * @param second_node
+ * @param corpus index of the corpus the transition was read from (>= 0)
+ * @param max_successors maximum number of transitions of the corpus, k > 0
+ * @return success/failure: 0 if the process was successful, 1 if in
+ * case of allocation error.
+ */
+int add_node_to_bounded_frequency_list(MarkovNode *first_node,
+                                       MarkovNode *second_node, int corpus,
+                                       int max_successors);
+
 /**
  * Free markov_chain and all of it's content from memory
  * @param chain_ptr markov_chain to free
@@ -104,6 +147,15 @@ MarkovNode *get_first_random_node(MarkovChain *markov_chain);
  */
 MarkovNode *get_next_random_node(MarkovNode *cur_markov_node);
 
+/**
+ * Deterministic part of get_next_random_node(): choose the next node for an
+ * already drawn random number.
+ * @param cur_markov_node MarkovNode to choose from
+ * @param random_number number in [0, cur_markov_node->total_frequency)
+ * @return MarkovNode of the chosen state
+ */
+MarkovNode *select_next_node(MarkovNode *cur_markov_node, int random_number);
+
 /**
  * Receive markov_chain, generate and print random sequences out of it. The
  * sequence most have at least 2 words in it.
@@ -115,4 +167,105 @@ MarkovNode *get_next_random_node(MarkovNode *cur_markov_node);
 void generate_random_sequence(MarkovChain *markov_chain,
                               MarkovNode *first_node, int max_length);
 
+/**
+ * Collect the nodes a blended sequence may start with: not a "last state",
+ * and with at least one transition of positive weight. Each corpus spreads
+ * its weight evenly over the nodes it starts a transition from, so a node
+ * seen only in a lightly weighted corpus is a rare start. Collect once per
+ * weights and pass the result to get_first_blended_node() for each sequence.
+ * @param markov_chain
+ * @param weights weight of each corpus, weights[i] >= 0, NULL to accept any
+ * node with a transition, all equally likely
+ * @param num_corpora number of entries in weights; transitions of corpora
+ * beyond it get weight 0
+ * @param first_nodes out parameter, room for database->size nodes
+ * @param start_weights out parameter, room for database->size entries: entry
+ * i is the summed start weight of first_nodes[0] .. first_nodes[i]. Not
+ * used, and may be NULL, if weights is NULL.
+ * @return number of nodes written to first_nodes, -1 in case of allocation
+ * error
+ */
+int get_first_nodes(MarkovChain *markov_chain, const double *weights,
+                    int num_corpora, MarkovNode **first_nodes,
+                    double *start_weights);
+
+/**
+ * Get one random markov node out of the ones collected by get_first_nodes(),
+ * by its start weight.
+ * @param first_nodes
+ * @param start_weights as filled by get_first_nodes()
+ * @param num_first_nodes
+ * @return the chosen MarkovNode, NULL if num_first_nodes is 0
+ */
+MarkovNode *get_first_blended_node(MarkovNode **first_nodes,
+                                   const double *start_weights,
+                                   int num_first_nodes);
+
+/**
+ * Deterministic part of get_first_blended_node(): choose the first node for
+ * an already drawn random fraction.
+ * @param first_nodes
+ * @param start_weights as filled by get_first_nodes()
+ * @param num_first_nodes
+ * @param fraction random fraction in [0, 1)
+ * @return the chosen MarkovNode, NULL if num_first_nodes is 0
+ */
+MarkovNode *select_first_blended_node(MarkovNode **first_nodes,
+                                      const double *start_weights,
+                                      int num_first_nodes, double fraction);
+
+/**
+ * Choose the next node out of a blend of corpora: the frequencies of each
+ * corpus are divided by that corpus' total out of the current node, and the
+ * resulting probabilities mixed in proportion to the corpora's weights. The
+ * weights are thus shares of the blend, whatever the sizes of the corpora.
+ * The blend is computed on the fly, so changing weights between calls is
+ * free.
+ * @param cur_markov_node MarkovNode to choose from
+ * @param weights weight of each corpus, weights[i] >= 0
+ * @param num_corpora number of entries in weights
+ * @return MarkovNode of the chosen state, NULL if the node has no transition
+ * with positive weight.
+ */
+MarkovNode *get_next_blended_node(MarkovNode *cur_markov_node,
+                                  const double *weights, int num_corpora);
+
+/**
+ * Deterministic part of get_next_blended_node(): choose the next node for an
+ * already drawn random fraction.
+ * @param cur_markov_node MarkovNode to choose from
+ * @param weights weight of each corpus, weights[i] >= 0
+ * @param num_corpora number of entries in weights
+ * @param fraction random fraction in [0, 1)
+ * @return MarkovNode of the chosen state, NULL if the node has no transition
+ * with positive weight.
+ */
+MarkovNode *select_next_blended_node(MarkovNode *cur_markov_node,
+                                     const double *weights, int num_corpora,
+                                     double fraction);
+
+/**
+ * Sum of the blended weights of the transitions out of markov_node, that is
+ * the sum of the weights of the corpora with a transition out of it.
+ * @param markov_node
+ * @param weights weight of each corpus, weights[i] >= 0
+ * @param num_corpora number of entries in weights
+ * @return the blended total, 0 if no transition has positive weight
+ */
+double get_blended_total(const MarkovNode *markov_node,
+                         const double *weights, int num_corpora);
+
+/**
+ * Same as generate_random_sequence(), choosing transitions with
+ * get_next_blended_node().
+ * @param markov_chain
+ * @param first_node markov_node to start with
+ * @param max_length maximum length of chain to generate
+ * @param weights weight of each corpus, weights[i] >= 0
+ * @param num_corpora number of entries in weights
+ */
+void generate_blended_sequence(MarkovChain *markov_chain,
+                               MarkovNode *first_node, int max_length,
+                               const double *weights, int num_corpora);
+
 #endif /* MARKOV_CHAIN_H */
@@ -0,0 +1,238 @@
+#include "markov_score.h"
+#include "parallel.h"
+
+#include <math.h>
+#include <string.h>
+
+/**
+ * Shared state of one score_sequences() call.
+ */
+typedef struct ScoreJob {
+    const MarkovIndex *index;
+    void *const *const *sequences;
+    const int *lengths;
+    double smoothing;
+    SequenceScore *scores;
+} ScoreJob;
+
+/**
+ * Merge sort nodes[0, size) by comp_f, tmp has room for size nodes.
+ * qsort() can't be used since it gives no way to pass comp_f along.
+ */
+static void sort_nodes(MarkovNode **nodes, MarkovNode **tmp, int size,
+                       comp_func comp_f) {
+    if (size < 2) {
+        return;
+    }
+    int half = size / 2;
+    sort_nodes(nodes, tmp, half, comp_f);
+    sort_nodes(nodes + half, tmp, size - half, comp_f);
+    int i = 0, j = half, k = 0;
+    while (i < half && j < size) {
+        if (comp_f(nodes[j]->data, nodes[i]->data) < 0) {
+            tmp[k++] = nodes[j++];
+        } else {
+            tmp[k++] = nodes[i++];
+        }
+    }
+    while (i < half) {
+        tmp[k++] = nodes[i++];
+    }
+    memcpy(nodes, tmp, sizeof(MarkovNode *) * j);
+}
+
+
+static int compare_transitions(const void *transition1,
+                               const void *transition2) {
+    int id1 = ((const IndexedTransition *) transition1)->id;
+    int id2 = ((const IndexedTransition *) transition2)->id;
+    return (id1 > id2) - (id1 < id2);
+}
+
+
+/**
+ * Fill the transitions of index: for each node, the transitions of its
+ * frequency_list sorted by next state, those of several corpora merged.
+ * index->first_transitions and index->transitions must have room for
+ * size + 1 entries and for all the transitions of the chain.
+ */
+static void index_transitions(MarkovIndex *index, MarkovChain *markov_chain) {
+    int end = 0;
+    // Nodes are walked in database order, which is the order of their ids.
+    for (Node *node = markov_chain->database->first; node != NULL;
+         node = node->next) {
+        MarkovNode *markov_node = node->data;
+        IndexedTransition *transitions = index->transitions + end;
+        for (int i = 0; i < markov_node->frequency_size; i++) {
+            transitions[i].id = markov_node->frequency_list[i].markov_node->id;
+            transitions[i].count = markov_node->frequency_list[i].frequency;
+        }
+        qsort(transitions, markov_node->frequency_size,
+              sizeof(IndexedTransition), compare_transitions);
+        int num_transitions = 0;
+        for (int i = 0; i < markov_node->frequency_size; i++) {
+            if (num_transitions > 0 &&
+                transitions[num_transitions - 1].id == transitions[i].id) {
+                transitions[num_transitions - 1].count += transitions[i].count;
+            } else {
+                transitions[num_transitions++] = transitions[i];
+            }
+        }
+        index->first_transitions[markov_node->id] = end;
+        end += num_transitions;
+    }
+    index->first_transitions[index->size] = end;
+}
+
+
+MarkovIndex *build_markov_index(MarkovChain *markov_chain) {
+    MarkovIndex *index = malloc(sizeof(MarkovIndex));
+    if (index == NULL) {
+        return NULL;
+    }
+    int size = markov_chain->database->size;
+    int num_transitions = 0;
+    for (Node *node = markov_chain->database->first; node != NULL;
+         node = node->next) {
+        num_transitions += node->data->frequency_size;
+    }
+    index->nodes = malloc(sizeof(MarkovNode *) * (size + 1));
+    index->first_transitions = malloc(sizeof(int) * (size + 1));
+    index->transitions = malloc(sizeof(IndexedTransition) *
+                                (num_transitions + 1));
+    MarkovNode **tmp = malloc(sizeof(MarkovNode *) * (size + 1));
+    if (index->nodes == NULL || index->first_transitions == NULL ||
+        index->transitions == NULL || tmp == NULL) {
+        free(index->nodes);
+        free(index->first_transitions);
+        free(index->transitions);
+        free(tmp);
+        free(index);
+        return NULL;
+    }
+    int i = 0;
+    for (Node *node = markov_chain->database->first; node != NULL;
+         node = node->next) {
+        index->nodes[i++] = node->data;
+    }
+    index->size = size;
+    index->comp_f = markov_chain->comp_f;
+    index->is_last = markov_chain->is_last;
+    index_transitions(index, markov_chain);
+    sort_nodes(index->nodes, tmp, size, index->comp_f);
+    free(tmp);
+    return index;
+}
+
+
+void free_markov_index(MarkovIndex **index_ptr) {
+    if (index_ptr == NULL || *index_ptr == NULL) {
+        return;
+    }
+    free((*index_ptr)->nodes);
+    free((*index_ptr)->first_transitions);
+    free((*index_ptr)->transitions);
+    free(*index_ptr);
+    *index_ptr = NULL;
+}
+
+
+MarkovNode *get_node_from_index(const MarkovIndex *index,
+                                const void *data_ptr) {
+    int low = 0, high = index->size;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        int res = index->comp_f(index->nodes[middle]->data, data_ptr);
+        if (res == 0) {
+            return index->nodes[middle];
+        }
+        if (res < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return NULL;
+}
+
+
+/**
+ * Number of times to_node followed from_node, summed over all corpora.
+ */
+static int transition_count(const MarkovIndex *index,
+                            const MarkovNode *from_node,
+                            const MarkovNode *to_node) {
+    int low = index->first_transitions[from_node->id];
+    int high = index->first_transitions[from_node->id + 1];
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        int id = index->transitions[middle].id;
+        if (id == to_node->id) {
+            return index->transitions[middle].count;
+        }
+        if (id < to_node->id) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return 0;
+}
+
+
+SequenceScore score_sequence(const MarkovIndex *index, void *const *tokens,
+                             int num_tokens, double smoothing) {
+    SequenceScore score = {0, 1, 0};
+    if (num_tokens < 2) {
+        return score;
+    }
+    MarkovNode *prev_node = get_node_from_index(index, tokens[0]);
+    bool prev_last = index->is_last(tokens[0]);
+    for (int i = 1; i < num_tokens; i++) {
+        MarkovNode *cur_node = get_node_from_index(index, tokens[i]);
+        if (!prev_last) {
+            double count = 0, total = 0;
+            if (prev_node != NULL) {
+                total = prev_node->total_frequency;
+                if (cur_node != NULL) {
+                    count = transition_count(index, prev_node, cur_node);
+                }
+            }
+            count += smoothing;
+            total += smoothing * index->size;
+            if (count > 0 && total > 0) {
+                score.log_probability += log(count / total);
+            } else {
+                score.log_probability = -INFINITY;
+            }
+            score.num_transitions++;
+        }
+        prev_node = cur_node;
+        prev_last = index->is_last(tokens[i]);
+    }
+    if (score.num_transitions > 0) {
+        score.perplexity = exp(-score.log_probability /
+                               score.num_transitions);
+    }
+    return score;
+}
+
+
+/**
+ * Score sequences first .. last - 1 of a ScoreJob.
+ */
+static void score_range(void *context, int first, int last) {
+    ScoreJob *job = context;
+    for (int i = first; i < last; i++) {
+        job->scores[i] = score_sequence(job->index, job->sequences[i],
+                                        job->lengths[i], job->smoothing);
+    }
+}
+
+
+void score_sequences(const MarkovIndex *index, void *const *const *sequences,
+                     const int *lengths, int num_sequences, double smoothing,
+                     int num_threads, SequenceScore *scores) {
+    ScoreJob job = {index, sequences, lengths, smoothing, scores};
+    run_parallel(num_sequences, num_threads, score_range, &job);
+}
@@ -0,0 +1,96 @@
+#ifndef _MARKOV_SCORE_H
+#define _MARKOV_SCORE_H
+
+#include "markov_chain.h"
+
+/**
+ * A transition of a MarkovIndex, counted over all corpora.
+ */
+typedef struct IndexedTransition {
+    int id; // MarkovNode::id of the next state
+    int count;
+} IndexedTransition;
+
+/**
+ * Read only view of a markov_chain's states, sorted with the chain's comp_f
+ * so tokens are looked up in O(log n) instead of walking the database, and
+ * of its transitions, sorted by the id of the next state so a transition is
+ * looked up in O(log out-degree). Must be rebuilt if the chain is trained
+ * further.
+ */
+typedef struct MarkovIndex {
+    MarkovNode **nodes;
+    int size;
+    comp_func comp_f;
+    is_last is_last; // sequences restart after a last state, as in training
+    // transitions out of the node of id i are transitions[first_transitions[i]]
+    // .. transitions[first_transitions[i + 1] - 1], size + 1 entries
+    int *first_transitions;
+    IndexedTransition *transitions;
+} MarkovIndex;
+
+/**
+ * Likelihood of a token sequence under a chain.
+ */
+typedef struct SequenceScore {
+    double log_probability; // natural log of the probability of all transitions
+    double perplexity; // exp(-log_probability / num_transitions)
+    int num_transitions;
+} SequenceScore;
+
+/**
+ * Build the index of the given markov_chain.
+ * @param markov_chain
+ * @return dynamically allocated index, NULL in case of allocation error
+ */
+MarkovIndex *build_markov_index(MarkovChain *markov_chain);
+
+/**
+ * Free index and set it to NULL. The chain itself is not touched.
+ * @param index_ptr index to free
+ */
+void free_markov_index(MarkovIndex **index_ptr);
+
+/**
+ * Look a state up in the index.
+ * @param index
+ * @param data_ptr the state to look for
+ * @return MarkovNode of the state, NULL if it is not in the chain
+ */
+MarkovNode *get_node_from_index(const MarkovIndex *index,
+                                const void *data_ptr);
+
+/**
+ * Score every transition of tokens under the chain. tokens may hold several
+ * sentences: as in training, no transition is counted out of a "last state",
+ * so the step from a sentence end to the next sentence start is skipped and
+ * not counted in num_transitions. With add-k smoothing,
+ * P(b | a) = (count(a, b) + k) / (total(a) + k * V) where V is the number of
+ * states; counts of all corpora are added up. Without smoothing, an unseen
+ * transition or state makes log_probability -INFINITY.
+ * @param index index of the chain
+ * @param tokens states of the sequence, in order
+ * @param num_tokens number of tokens
+ * @param smoothing k >= 0
+ * @return score of the sequence; a sequence without transitions has
+ * log_probability 0 and perplexity 1
+ */
+SequenceScore score_sequence(const MarkovIndex *index, void *const *tokens,
+                             int num_tokens, double smoothing);
+
+/**
+ * Score many sequences with score_sequence(), split between num_threads
+ * threads. The chain must not be modified meanwhile.
+ * @param index index of the chain
+ * @param sequences tokens of each sequence
+ * @param lengths number of tokens of each sequence
+ * @param num_sequences
+ * @param smoothing k >= 0
+ * @param num_threads number of threads to use, the calling thread included
+ * @param scores out parameter, one score per sequence
+ */
+void score_sequences(const MarkovIndex *index, void *const *const *sequences,
+                     const int *lengths, int num_sequences, double smoothing,
+                     int num_threads, SequenceScore *scores);
+
+#endif /* _MARKOV_SCORE_H */
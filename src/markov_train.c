@@ -0,0 +1,84 @@
+#include "markov_train.h"
+#include "read_pipeline.h"
+
+#include <string.h>
+
+#define LINE_DELIMITERS "\n"
+
+/**
+ * Train the chain on the words of a single line, or of a piece of it.
+ * @param prev_node last node of the previous piece of the line, NULL at the
+ * start of a line; updated
+ * @param word_count words read so far, updated
+ * @return 0 on success, 1 in case of allocation error
+ */
+static int train_line(char *line, const char *delimiters,
+                      MarkovNode **prev_node, int words_to_read,
+                      int *word_count, MarkovChain *markov_chain, int corpus,
+                      int max_successors) {
+    char *save_ptr;
+    char *word = strtok_r(line, delimiters, &save_ptr);
+    while (word != NULL && *word_count < words_to_read) {
+        Node *current_node = add_to_database(markov_chain, word);
+        if (current_node == NULL) {
+            return EXIT_FAILURE;
+        }
+        if (*prev_node != NULL) {
+            int res = max_successors > 0 ?
+                add_node_to_bounded_frequency_list(*prev_node,
+                    current_node->data, corpus, max_successors) :
+                add_node_to_corpus_frequency_list(*prev_node,
+                    current_node->data, corpus);
+            if (res != 0) {
+                return EXIT_FAILURE;
+            }
+        }
+        if (markov_chain->is_last(word)) {
+            *prev_node = NULL;
+        } else {
+            *prev_node = current_node->data;
+        }
+        (*word_count)++;
+        word = strtok_r(NULL, delimiters, &save_ptr);
+    }
+    return EXIT_SUCCESS;
+}
+
+
+int train_from_file(FILE *fp, const char *delimiters, int words_to_read,
+                    int *word_count, MarkovChain *markov_chain, int corpus,
+                    int max_successors) {
+    ReadPipeline *pipeline = start_read_pipeline(fp, TRAIN_BUFFER_SIZE,
+                                                 delimiters);
+    if (pipeline == NULL) {
+        return EXIT_FAILURE;
+    }
+    int res = EXIT_SUCCESS;
+    char *chunk;
+    MarkovNode *prev_node = NULL;
+    bool line_cut = false; // the previous chunk ended inside a line
+    while (res == EXIT_SUCCESS && *word_count < words_to_read &&
+           (chunk = read_pipeline_next(pipeline)) != NULL) {
+        // The first line goes on with the previous chunk if that one was
+        // cut inside a line.
+        bool continued = line_cut && *chunk != '\n';
+        size_t length = strlen(chunk);
+        line_cut = length > 0 && chunk[length - 1] != '\n';
+        char *save_ptr;
+        char *line = strtok_r(chunk, LINE_DELIMITERS, &save_ptr);
+        while (res == EXIT_SUCCESS && line != NULL &&
+               *word_count < words_to_read) {
+            if (!continued) {
+                prev_node = NULL;
+            }
+            continued = false;
+            res = train_line(line, delimiters, &prev_node, words_to_read,
+                             word_count, markov_chain, corpus,
+                             max_successors);
+            line = strtok_r(NULL, LINE_DELIMITERS, &save_ptr);
+        }
+        read_pipeline_release(pipeline);
+    }
+    stop_read_pipeline(&pipeline);
+    return res;
+}
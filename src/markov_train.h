@@ -0,0 +1,31 @@
+#ifndef _MARKOV_TRAIN_H
+#define _MARKOV_TRAIN_H
+
+#include "markov_chain.h"
+
+#define TRAIN_BUFFER_SIZE (1 << 20)
+
+/**
+ * Train markov_chain on the words of a text file, each word a state (the
+ * chain's functions must handle NUL terminated strings). Transitions do not
+ * cross line ends, nor follow a "last state". The file is read by a
+ * read_pipeline in chunks of TRAIN_BUFFER_SIZE bytes, so reading the next
+ * chunk overlaps with adding the current one to the chain, and lines of any
+ * length are trained whole.
+ * @param fp file to read, stays owned by the caller
+ * @param delimiters bytes separating the words of a line
+ * @param words_to_read stop once word_count reaches it
+ * @param word_count words read so far, e.g. from previous corpora, updated
+ * @param markov_chain chain to train
+ * @param corpus index of the corpus fp holds, see
+ * add_node_to_corpus_frequency_list()
+ * @param max_successors if positive, keep at most that many transitions per
+ * word and corpus with add_node_to_bounded_frequency_list(), exact counting
+ * otherwise
+ * @return 0 on success, 1 in case of allocation error
+ */
+int train_from_file(FILE *fp, const char *delimiters, int words_to_read,
+                    int *word_count, MarkovChain *markov_chain, int corpus,
+                    int max_successors);
+
+#endif /* _MARKOV_TRAIN_H */
@@ -0,0 +1,268 @@
+#include "markov_walks.h"
+#include "counter_rng.h"
+#include "parallel.h"
+
+#include <string.h>
+
+#define INITIAL_CAPACITY 16
+
+/**
+ * Shared state of one generate_walks_seekable() call.
+ */
+typedef struct SeekableWalks {
+    MarkovNode **first_nodes; // nodes a walk may start with
+    const double *start_weights; // of first_nodes, if weights is not NULL
+    int num_first_nodes;
+    uint64_t seed;
+    uint64_t first_walk;
+    int max_length;
+    const double *weights;
+    int num_corpora;
+    int32_t *states; // walk i is written at states[i * max_length]
+    int *lengths;
+} SeekableWalks;
+
+MarkovWalks *create_walks(void) {
+    MarkovWalks *walks = malloc(sizeof(MarkovWalks));
+    if (walks == NULL) {
+        return NULL;
+    }
+    walks->states = malloc(sizeof(int32_t) * INITIAL_CAPACITY);
+    walks->offsets = malloc(sizeof(uint64_t) * (INITIAL_CAPACITY + 1));
+    if (walks->states == NULL || walks->offsets == NULL) {
+        free(walks->states);
+        free(walks->offsets);
+        free(walks);
+        return NULL;
+    }
+    walks->offsets[0] = 0;
+    walks->num_walks = 0;
+    walks->states_capacity = INITIAL_CAPACITY;
+    walks->walks_capacity = INITIAL_CAPACITY;
+    return walks;
+}
+
+
+void free_walks(MarkovWalks **walks_ptr) {
+    if (walks_ptr == NULL || *walks_ptr == NULL) {
+        return;
+    }
+    free((*walks_ptr)->states);
+    free((*walks_ptr)->offsets);
+    free(*walks_ptr);
+    *walks_ptr = NULL;
+}
+
+
+/**
+ * Make room for num_walks more walks holding num_states states in total.
+ * @return 0 on success, 1 in case of allocation error
+ */
+static int reserve_walks(MarkovWalks *walks, int num_walks,
+                         uint64_t num_states) {
+    if (walks->num_walks + num_walks > walks->walks_capacity) {
+        int capacity = walks->walks_capacity * 2;
+        if (capacity < walks->num_walks + num_walks) {
+            capacity = walks->num_walks + num_walks;
+        }
+        uint64_t *offsets = realloc(walks->offsets,
+                                    sizeof(uint64_t) * (capacity + 1));
+        if (offsets == NULL) {
+            return EXIT_FAILURE;
+        }
+        walks->offsets = offsets;
+        walks->walks_capacity = capacity;
+    }
+    uint64_t needed = walks->offsets[walks->num_walks] + num_states;
+    if (needed > walks->states_capacity) {
+        uint64_t capacity = walks->states_capacity * 2;
+        if (capacity < needed) {
+            capacity = needed;
+        }
+        int32_t *states = realloc(walks->states, sizeof(int32_t) * capacity);
+        if (states == NULL) {
+            return EXIT_FAILURE;
+        }
+        walks->states = states;
+        walks->states_capacity = capacity;
+    }
+    return EXIT_SUCCESS;
+}
+
+
+int generate_walks_columnar(MarkovChain *markov_chain, MarkovNode *first_node,
+                            int max_length, int num_walks, MarkovWalks *walks) {
+    for (int i = 0; i < num_walks; i++) {
+        if (reserve_walks(walks, 1, max_length) != EXIT_SUCCESS) {
+            printf(ALLOCATION_ERROR_MESSAGE);
+            return EXIT_FAILURE;
+        }
+        uint64_t end = walks->offsets[walks->num_walks];
+        MarkovNode *current_node = first_node;
+        if (current_node == NULL) {
+            current_node = get_first_random_node(markov_chain);
+        }
+        int word_count = 0;
+        while (current_node != NULL && word_count < max_length) {
+            walks->states[end++] = current_node->id;
+            word_count++;
+            if (current_node->frequency_list == NULL) {
+                break;
+            }
+            current_node = get_next_random_node(current_node);
+        }
+        walks->num_walks++;
+        walks->offsets[walks->num_walks] = end;
+    }
+    return EXIT_SUCCESS;
+}
+
+
+/**
+ * Generate walk i of context->first_walk + i into its slot of
+ * context->states, using only the random stream of that walk.
+ */
+static void generate_seekable_walk(const SeekableWalks *context, int i) {
+    CounterRng rng;
+    init_counter_rng(&rng, context->seed, context->first_walk + i);
+    int32_t *states = context->states + (uint64_t) i * context->max_length;
+    MarkovNode *current_node;
+    if (context->weights != NULL) {
+        current_node = select_first_blended_node(context->first_nodes,
+            context->start_weights, context->num_first_nodes,
+            counter_rng_fraction(&rng));
+    } else {
+        current_node = context->first_nodes[
+            counter_rng_number(&rng, context->num_first_nodes)];
+    }
+    int word_count = 0;
+    while (current_node != NULL && word_count < context->max_length) {
+        states[word_count++] = current_node->id;
+        if (context->weights != NULL) {
+            current_node = select_next_blended_node(current_node,
+                context->weights, context->num_corpora,
+                counter_rng_fraction(&rng));
+        } else if (current_node->frequency_list != NULL) {
+            current_node = select_next_node(current_node,
+                counter_rng_number(&rng, current_node->total_frequency));
+        } else {
+            current_node = NULL;
+        }
+    }
+    context->lengths[i] = word_count;
+}
+
+
+/**
+ * Generate walks first .. last - 1 of a SeekableWalks.
+ */
+static void seek_range(void *context, int first, int last) {
+    for (int i = first; i < last; i++) {
+        generate_seekable_walk(context, i);
+    }
+}
+
+
+int generate_walks_seekable(MarkovChain *markov_chain, uint64_t seed,
+                            uint64_t first_walk, int num_walks,
+                            int max_length, const double *weights,
+                            int num_corpora, int num_threads,
+                            MarkovWalks *walks) {
+    if (num_walks <= 0 || max_length <= 0) {
+        return EXIT_SUCCESS;
+    }
+    MarkovNode **first_nodes = malloc(sizeof(MarkovNode *) *
+                                      (markov_chain->database->size + 1));
+    double *start_weights = NULL;
+    if (weights != NULL) {
+        start_weights = malloc(sizeof(double) *
+                               (markov_chain->database->size + 1));
+    }
+    int *lengths = malloc(sizeof(int) * num_walks);
+    uint64_t num_slots = (uint64_t) num_walks * max_length;
+    int num_first_nodes = -1;
+    if (first_nodes != NULL && lengths != NULL &&
+        (weights == NULL || start_weights != NULL) &&
+        reserve_walks(walks, num_walks, num_slots) == EXIT_SUCCESS) {
+        num_first_nodes = get_first_nodes(markov_chain, weights, num_corpora,
+                                          first_nodes, start_weights);
+    }
+    if (num_first_nodes < 0) {
+        printf(ALLOCATION_ERROR_MESSAGE);
+        free(first_nodes);
+        free(start_weights);
+        free(lengths);
+        return EXIT_FAILURE;
+    }
+    uint64_t end = walks->offsets[walks->num_walks];
+    if (num_first_nodes == 0) {
+        memset(lengths, 0, sizeof(int) * num_walks);
+    } else {
+        SeekableWalks context = {first_nodes, start_weights, num_first_nodes,
+                                 seed, first_walk, max_length, weights,
+                                 num_corpora, walks->states + end, lengths};
+        run_parallel(num_walks, num_threads, seek_range, &context);
+    }
+    // Pack the fixed size slots back to back. Each slot starts at or after
+    // its packed position, so moving them in order never overwrites a walk
+    // that is still to be moved.
+    for (int i = 0; i < num_walks; i++) {
+        memmove(walks->states + end,
+                walks->states + walks->offsets[walks->num_walks] +
+                (uint64_t) i * max_length,
+                sizeof(int32_t) * lengths[i]);
+        end += lengths[i];
+        walks->offsets[walks->num_walks + i + 1] = end;
+    }
+    walks->num_walks += num_walks;
+    free(first_nodes);
+    free(start_weights);
+    free(lengths);
+    return EXIT_SUCCESS;
+}
+
+
+MarkovNode **get_nodes_by_id(MarkovChain *markov_chain) {
+    MarkovNode **nodes = malloc(sizeof(MarkovNode *) *
+                                (markov_chain->database->size + 1));
+    if (nodes == NULL) {
+        printf(ALLOCATION_ERROR_MESSAGE);
+        return NULL;
+    }
+    for (Node *node = markov_chain->database->first; node != NULL;
+         node = node->next) {
+        nodes[node->data->id] = node->data;
+    }
+    return nodes;
+}
+
+
+void print_walk(MarkovChain *markov_chain, MarkovNode **nodes_by_id,
+                const MarkovWalks *walks, int walk) {
+    for (uint64_t i = walks->offsets[walk]; i < walks->offsets[walk + 1];
+         i++) {
+        if (i > walks->offsets[walk]) {
+            printf(" ");
+        }
+        markov_chain->print_f(nodes_by_id[walks->states[i]]->data);
+    }
+    printf("\n");
+}
+
+
+int write_walks(const MarkovWalks *walks, FILE *fp) {
+    uint32_t version = WALKS_FILE_VERSION;
+    uint64_t num_walks = walks->num_walks;
+    uint64_t num_states = walks->offsets[walks->num_walks];
+    if (fwrite(WALKS_FILE_MAGIC, strlen(WALKS_FILE_MAGIC), 1, fp) != 1 ||
+        fwrite(&version, sizeof(version), 1, fp) != 1 ||
+        fwrite(&num_walks, sizeof(num_walks), 1, fp) != 1 ||
+        fwrite(&num_states, sizeof(num_states), 1, fp) != 1 ||
+        fwrite(walks->offsets, sizeof(uint64_t), num_walks + 1, fp)
+        != num_walks + 1 ||
+        fwrite(walks->states, sizeof(int32_t), num_states, fp)
+        != num_states) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
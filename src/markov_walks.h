@@ -0,0 +1,103 @@
+#ifndef _MARKOV_WALKS_H
+#define _MARKOV_WALKS_H
+
+#include "markov_chain.h"
+#include <stdint.h> // For int32_t, uint64_t
+
+#define WALKS_FILE_MAGIC "MCWK"
+#define WALKS_FILE_VERSION 1
+
+/**
+ * Many generated sequences stored as state ids (MarkovNode::id), back to
+ * back in one array. Walk i is states[offsets[i]] .. states[offsets[i+1]-1].
+ */
+typedef struct MarkovWalks {
+    int32_t *states;
+    uint64_t *offsets; // num_walks + 1 entries, offsets[0] == 0
+    int num_walks;
+    uint64_t states_capacity;
+    int walks_capacity;
+} MarkovWalks;
+
+/**
+ * Allocate an empty set of walks.
+ * @return dynamically allocated walks, NULL in case of allocation error
+ */
+MarkovWalks *create_walks(void);
+
+/**
+ * Free walks and all of it's content from memory
+ * @param walks_ptr walks to free, set to NULL
+ */
+void free_walks(MarkovWalks **walks_ptr);
+
+/**
+ * Generate num_walks random sequences and append their state ids to walks.
+ * Walks follow the same rules, and consume the same random numbers, as
+ * generate_random_sequence(), but nothing is printed.
+ * @param markov_chain
+ * @param first_node markov_node every walk starts with, if NULL- choose a
+ * random markov_node for each walk
+ * @param max_length maximum length of each walk
+ * @param num_walks number of walks to generate
+ * @param walks walks to append to
+ * @return 0 on success, 1 in case of allocation error
+ */
+int generate_walks_columnar(MarkovChain *markov_chain, MarkovNode *first_node,
+                            int max_length, int num_walks, MarkovWalks *walks);
+
+/**
+ * Generate walks first_walk .. first_walk + num_walks - 1 of a seekable set
+ * of walks and append their state ids to walks. Walk n draws only from the
+ * counter based random stream (seed, n), see counter_rng.h, so it is the same
+ * whichever range it is generated in and however many threads are used.
+ * rand() is not used.
+ * @param markov_chain
+ * @param seed
+ * @param first_walk index of the first walk to generate
+ * @param num_walks number of walks to generate
+ * @param max_length maximum length of each walk
+ * @param weights weight of each corpus to blend transitions with, as in
+ * get_next_blended_node(); NULL to use the plain frequencies
+ * @param num_corpora number of entries in weights
+ * @param num_threads number of threads to use, the calling thread included
+ * @param walks walks to append to
+ * @return 0 on success, 1 in case of allocation error
+ */
+int generate_walks_seekable(MarkovChain *markov_chain, uint64_t seed,
+                            uint64_t first_walk, int num_walks,
+                            int max_length, const double *weights,
+                            int num_corpora, int num_threads,
+                            MarkovWalks *walks);
+
+/**
+ * Map state ids back to the chain's nodes.
+ * @param markov_chain
+ * @return dynamically allocated array, entry i is the node whose id is i.
+ * NULL in case of allocation error
+ */
+MarkovNode **get_nodes_by_id(MarkovChain *markov_chain);
+
+/**
+ * Print one walk the way generate_random_sequence() prints a sequence.
+ * @param markov_chain
+ * @param nodes_by_id as returned by get_nodes_by_id()
+ * @param walks
+ * @param walk index of the walk in walks
+ */
+void print_walk(MarkovChain *markov_chain, MarkovNode **nodes_by_id,
+                const MarkovWalks *walks, int walk);
+
+/**
+ * Write walks to fp in binary, in host byte order:
+ * - 4 bytes WALKS_FILE_MAGIC, uint32_t WALKS_FILE_VERSION
+ * - uint64_t number of walks, uint64_t total number of states
+ * - uint64_t offsets[number of walks + 1]
+ * - int32_t states[total number of states]
+ * @param walks
+ * @param fp binary stream to write to
+ * @return 0 on success, 1 on write error
+ */
+int write_walks(const MarkovWalks *walks, FILE *fp);
+
+#endif /* _MARKOV_WALKS_H */
@@ -0,0 +1,64 @@
+#include "parallel.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/**
+ * A range of items run by one thread.
+ */
+typedef struct ParallelTask {
+    range_func range_f;
+    void *context;
+    int first;
+    int last;
+    bool threaded; // runs on a thread of its own
+} ParallelTask;
+
+static void *parallel_task(void *arg) {
+    ParallelTask *task = arg;
+    task->range_f(task->context, task->first, task->last);
+    return NULL;
+}
+
+
+void run_parallel(int num_items, int num_threads, range_func range_f,
+                  void *context) {
+    if (num_threads > num_items) {
+        num_threads = num_items;
+    }
+    ParallelTask *tasks = NULL;
+    pthread_t *threads = NULL;
+    if (num_threads > 1) {
+        tasks = malloc(sizeof(ParallelTask) * num_threads);
+        threads = malloc(sizeof(pthread_t) * num_threads);
+    }
+    if (tasks == NULL || threads == NULL) {
+        // Single threaded, or no memory to keep track of the threads.
+        range_f(context, 0, num_items);
+        free(tasks);
+        free(threads);
+        return;
+    }
+    for (int t = 0; t < num_threads; t++) {
+        tasks[t] = (ParallelTask) {range_f, context,
+            (int) ((long long) num_items * t / num_threads),
+            (int) ((long long) num_items * (t + 1) / num_threads), false};
+        if (t > 0) {
+            tasks[t].threaded = pthread_create(&threads[t], NULL,
+                                               parallel_task, &tasks[t]) == 0;
+        }
+    }
+    for (int t = 0; t < num_threads; t++) {
+        if (!tasks[t].threaded) {
+            parallel_task(&tasks[t]);
+        }
+    }
+    for (int t = 1; t < num_threads; t++) {
+        if (tasks[t].threaded) {
+            pthread_join(threads[t], NULL);
+        }
+    }
+    free(tasks);
+    free(threads);
+}
@@ -0,0 +1,25 @@
+#ifndef _PARALLEL_H
+#define _PARALLEL_H
+
+/**
+ * Work on the items first .. last - 1 of a job.
+ * @param context shared by all the ranges of the job
+ * @param first
+ * @param last
+ */
+typedef void (*range_func)(void *context, int first, int last);
+
+/**
+ * Split items 0 .. num_items - 1 into num_threads contiguous ranges and run
+ * range_f on each one on a thread of its own. The first range runs on the
+ * calling thread, as does any range whose thread could not be started, so
+ * the job always completes. Returns once every range is done.
+ * @param num_items
+ * @param num_threads number of threads to use, the calling thread included
+ * @param range_f
+ * @param context passed to range_f
+ */
+void run_parallel(int num_items, int num_threads, range_func range_f,
+                  void *context);
+
+#endif /* _PARALLEL_H */
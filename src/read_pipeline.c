@@ -0,0 +1,250 @@
+#include "read_pipeline.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NUM_BUFFERS 2
+#define NUM_POLL_FDS 2
+
+struct ReadPipeline {
+    int fd;
+    size_t buffer_size;
+    const char *delimiters; // bytes a line too long for a chunk is cut after
+    char *buffers[NUM_BUFFERS]; // each holds buffer_size + 1 bytes
+    char *carry; // start of a line cut at the end of the previous chunk
+    size_t carry_length;
+    bool source_eof; // read() reached end of file, reader side only
+    int wakeup[2]; // pipe written to on stop, wakes a reader blocked in poll
+
+    int head; // next buffer the reader fills
+    int tail; // next buffer handed to the consumer
+    int full_count; // buffers filled or held by the consumer
+    bool eof; // no chunk will be added to the queue anymore
+    bool stop; // consumer asked the reader to quit
+    bool threaded;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t not_full;
+    pthread_cond_t not_empty;
+};
+
+/**
+ * Wait until fd has data, or the pipeline is stopped, so that stopping never
+ * waits for a stalled writer on a pipe.
+ * @param pipeline
+ * @return true if fd can be read, false if the pipeline was stopped
+ */
+static bool wait_readable(ReadPipeline *pipeline) {
+    struct pollfd fds[NUM_POLL_FDS] = {
+        {pipeline->fd, POLLIN, 0},
+        {pipeline->wakeup[0], POLLIN, 0}
+    };
+    while (poll(fds, NUM_POLL_FDS, -1) < 0) {
+        if (errno != EINTR) {
+            return true; // let read() report the error
+        }
+    }
+    return fds[1].revents == 0;
+}
+
+/**
+ * Cut a chunk holding no newline after its last delimiter byte, so that a
+ * word is never split between two chunks.
+ * @param pipeline
+ * @param buffer the chunk
+ * @param length length of the chunk
+ * @return length of the cut chunk, length if it holds no delimiter
+ */
+static size_t cut_long_line(const ReadPipeline *pipeline, const char *buffer,
+                            size_t length) {
+    for (size_t cut = length; cut > 0; cut--) {
+        if (buffer[cut - 1] != '\0' &&
+            strchr(pipeline->delimiters, buffer[cut - 1]) != NULL) {
+            return cut;
+        }
+    }
+    return length;
+}
+
+/**
+ * Fill buffer with the carried over line start and fresh data, until it holds
+ * at least one whole line, and cut it after its last newline. The rest is
+ * carried over to the next chunk.
+ * @param pipeline
+ * @param buffer buffer to fill
+ * @return length of the chunk, 0 if the file is exhausted or the pipeline
+ * was stopped
+ */
+static size_t fill_buffer(ReadPipeline *pipeline, char *buffer) {
+    size_t length = pipeline->carry_length;
+    memcpy(buffer, pipeline->carry, length);
+    pipeline->carry_length = 0;
+    while (length < pipeline->buffer_size && !pipeline->source_eof) {
+        if (pipeline->threaded && !wait_readable(pipeline)) {
+            pipeline->source_eof = true;
+            return 0;
+        }
+        ssize_t bytes = read(pipeline->fd, buffer + length,
+                             pipeline->buffer_size - length);
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes <= 0) {
+            pipeline->source_eof = true;
+            break;
+        }
+        bool has_line = memchr(buffer + length, '\n', (size_t) bytes) != NULL;
+        length += (size_t) bytes;
+        if (has_line) {
+            // Hand complete lines over now rather than wait for a slow pipe
+            // to fill the whole buffer.
+            break;
+        }
+    }
+
+    size_t cut = length;
+    if (!pipeline->source_eof) {
+        while (cut > 0 && buffer[cut - 1] != '\n') {
+            cut--;
+        }
+        if (cut == 0) {
+            // A single line fills the whole buffer, hand over its whole
+            // words and carry the last one over with the rest of the line.
+            cut = cut_long_line(pipeline, buffer, length);
+        }
+    }
+    pipeline->carry_length = length - cut;
+    memcpy(pipeline->carry, buffer + cut, pipeline->carry_length);
+    buffer[cut] = '\0';
+    return cut;
+}
+
+static void *reader_thread(void *arg) {
+    ReadPipeline *pipeline = arg;
+    pthread_mutex_lock(&pipeline->lock);
+    while (true) {
+        while (pipeline->full_count == NUM_BUFFERS && !pipeline->stop) {
+            pthread_cond_wait(&pipeline->not_full, &pipeline->lock);
+        }
+        if (pipeline->stop) {
+            break;
+        }
+        char *buffer = pipeline->buffers[pipeline->head];
+        pthread_mutex_unlock(&pipeline->lock);
+        size_t length = fill_buffer(pipeline, buffer);
+        pthread_mutex_lock(&pipeline->lock);
+        if (length == 0) {
+            break;
+        }
+        pipeline->head = (pipeline->head + 1) % NUM_BUFFERS;
+        pipeline->full_count++;
+        pthread_cond_signal(&pipeline->not_empty);
+    }
+    pipeline->eof = true;
+    pthread_cond_signal(&pipeline->not_empty);
+    pthread_mutex_unlock(&pipeline->lock);
+    return NULL;
+}
+
+static void free_buffers(ReadPipeline *pipeline) {
+    for (int i = 0; i < NUM_BUFFERS; i++) {
+        free(pipeline->buffers[i]);
+    }
+    free(pipeline->carry);
+    free(pipeline);
+}
+
+ReadPipeline *start_read_pipeline(FILE *fp, size_t buffer_size,
+                                  const char *delimiters) {
+    ReadPipeline *pipeline = calloc(1, sizeof(ReadPipeline));
+    if (pipeline == NULL) {
+        return NULL;
+    }
+    pipeline->fd = fileno(fp);
+    pipeline->buffer_size = buffer_size;
+    pipeline->delimiters = delimiters;
+    pipeline->carry = malloc(buffer_size);
+    bool allocated = pipeline->carry != NULL;
+    for (int i = 0; i < NUM_BUFFERS; i++) {
+        pipeline->buffers[i] = malloc(buffer_size + 1);
+        allocated = allocated && pipeline->buffers[i] != NULL;
+    }
+    if (!allocated) {
+        free_buffers(pipeline);
+        return NULL;
+    }
+    pthread_mutex_init(&pipeline->lock, NULL);
+    pthread_cond_init(&pipeline->not_full, NULL);
+    pthread_cond_init(&pipeline->not_empty, NULL);
+    if (pipe(pipeline->wakeup) != 0) {
+        // Without a way to wake the reader, read synchronously instead.
+        pipeline->wakeup[0] = pipeline->wakeup[1] = -1;
+        return pipeline;
+    }
+    pipeline->threaded = true;
+    if (pthread_create(&pipeline->thread, NULL, reader_thread, pipeline) != 0) {
+        pipeline->threaded = false;
+    }
+    return pipeline;
+}
+
+char *read_pipeline_next(ReadPipeline *pipeline) {
+    if (!pipeline->threaded) {
+        char *buffer = pipeline->buffers[0];
+        return fill_buffer(pipeline, buffer) > 0 ? buffer : NULL;
+    }
+    pthread_mutex_lock(&pipeline->lock);
+    while (pipeline->full_count == 0 && !pipeline->eof) {
+        pthread_cond_wait(&pipeline->not_empty, &pipeline->lock);
+    }
+    char *chunk = NULL;
+    if (pipeline->full_count > 0) {
+        chunk = pipeline->buffers[pipeline->tail];
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+    return chunk;
+}
+
+void read_pipeline_release(ReadPipeline *pipeline) {
+    if (!pipeline->threaded) {
+        return;
+    }
+    pthread_mutex_lock(&pipeline->lock);
+    pipeline->tail = (pipeline->tail + 1) % NUM_BUFFERS;
+    pipeline->full_count--;
+    pthread_cond_signal(&pipeline->not_full);
+    pthread_mutex_unlock(&pipeline->lock);
+}
+
+void stop_read_pipeline(ReadPipeline **pipeline_ptr) {
+    if (pipeline_ptr == NULL || *pipeline_ptr == NULL) {
+        return;
+    }
+    ReadPipeline *pipeline = *pipeline_ptr;
+    if (pipeline->threaded) {
+        pthread_mutex_lock(&pipeline->lock);
+        pipeline->stop = true;
+        pthread_cond_signal(&pipeline->not_full);
+        pthread_mutex_unlock(&pipeline->lock);
+        char wakeup = 0;
+        ssize_t written;
+        do {
+            written = write(pipeline->wakeup[1], &wakeup, sizeof(wakeup));
+        } while (written < 0 && errno == EINTR);
+        pthread_join(pipeline->thread, NULL);
+    }
+    if (pipeline->wakeup[0] >= 0) {
+        close(pipeline->wakeup[0]);
+        close(pipeline->wakeup[1]);
+    }
+    pthread_cond_destroy(&pipeline->not_empty);
+    pthread_cond_destroy(&pipeline->not_full);
+    pthread_mutex_destroy(&pipeline->lock);
+    free_buffers(pipeline);
+    *pipeline_ptr = NULL;
+}
@@ -0,0 +1,48 @@
+#ifndef _READ_PIPELINE_H_
+#define _READ_PIPELINE_H_
+#include <stdio.h>  // For FILE
+#include <stddef.h> // For size_t
+
+/**
+ * Double buffered reader: a background thread reads the next large chunk of
+ * a file (or pipe) while the caller processes the current one, so disk
+ * latency and CPU work overlap. Chunks end at a line boundary, except for a
+ * line longer than a chunk: it is cut after a delimiter byte, so no word is
+ * split, and goes on in the next chunk. Such a chunk does not end with '\n'.
+ */
+typedef struct ReadPipeline ReadPipeline;
+
+/**
+ * Start reading fp in the background. fp must not have been read from yet.
+ * If no thread can be started, chunks are read synchronously instead.
+ * @param fp file to read, stays owned by the caller
+ * @param buffer_size size of each chunk buffer; a line longer than that is
+ * handed over in several pieces
+ * @param delimiters bytes separating the words of a line; a piece of a long
+ * line ends with one of them. A word longer than buffer_size is still cut.
+ * @return the pipeline, NULL in case of allocation error
+ */
+ReadPipeline *start_read_pipeline(FILE *fp, size_t buffer_size,
+                                  const char *delimiters);
+
+/**
+ * Wait for the next chunk. The chunk belongs to the caller, who may modify
+ * it, until read_pipeline_release() is called.
+ * @param pipeline
+ * @return NUL terminated chunk holding whole lines, NULL at end of file
+ */
+char *read_pipeline_next(ReadPipeline *pipeline);
+
+/**
+ * Hand the chunk returned by read_pipeline_next() back to the reader.
+ * @param pipeline
+ */
+void read_pipeline_release(ReadPipeline *pipeline);
+
+/**
+ * Stop the reader, even before end of file, and free the pipeline.
+ * @param pipeline_ptr pipeline to free, set to NULL
+ */
+void stop_read_pipeline(ReadPipeline **pipeline_ptr);
+
+#endif //_READ_PIPELINE_H_